@@ -0,0 +1,79 @@
+/*
+* render.c
+*
+* Status-line, JSON Lines and metrics rendering for countdown frames.
+* No ANSI colors for maximum compatibility with all terminals/logs.
+*/
+
+#include "render.h"
+
+#include <stdio.h>
+
+const char *const sink_names[] = { "bar", "lines", "jsonl", "metrics" };
+
+void print_bar(FILE *out, long long elapsed, long long total) {
+    const int BAR_WIDTH = 20;
+    float percentage = (total == 0) ? 1.0f : (float)elapsed / total;
+    int filled_width = (int)(percentage * BAR_WIDTH);
+
+    fputs(" [", out);
+    for (int i = 0; i < BAR_WIDTH; ++i) {
+        if (i < filled_width) putc('#', out);
+        else putc('-', out);
+    }
+    fprintf(out, "] %3d%%", (int)(percentage * 100));
+}
+
+/* Rewrites the whole metrics file through a rename, so readers never see a partial one */
+static void write_metrics(const char *path, const struct frame *f) {
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *out = fopen(tmp, "w");
+    if (!out) return;
+    fprintf(out, "# HELP sleeper_elapsed_seconds Time elapsed in the countdown.\n");
+    fprintf(out, "# TYPE sleeper_elapsed_seconds gauge\n");
+    fprintf(out, "sleeper_elapsed_seconds %.3f\n", f->elapsed_ns / 1e9);
+    fprintf(out, "# HELP sleeper_remaining_seconds Time left in the countdown.\n");
+    fprintf(out, "# TYPE sleeper_remaining_seconds gauge\n");
+    fprintf(out, "sleeper_remaining_seconds %.3f\n", (f->total_ns - f->elapsed_ns) / 1e9);
+    fprintf(out, "# HELP sleeper_progress_ratio Fraction of the countdown completed.\n");
+    fprintf(out, "# TYPE sleeper_progress_ratio gauge\n");
+    fprintf(out, "sleeper_progress_ratio %.4f\n", f->total_ns ? (double)f->elapsed_ns / f->total_ns : 1.0);
+    fprintf(out, "# HELP sleeper_done Whether the countdown has finished (1) or was interrupted (-1).\n");
+    fprintf(out, "# TYPE sleeper_done gauge\n");
+    fprintf(out, "sleeper_done %d\n", f->state == FRAME_DONE ? 1 : f->state == FRAME_INTERRUPTED ? -1 : 0);
+    if (fclose(out) == 0) rename(tmp, path);
+}
+
+void render_frame(FILE *out, enum sink_kind kind, const char *path, const struct frame *f) {
+    static const char *const states[] = { "running", "done", "interrupted" };
+    long total = (long)((f->total_ns + NS_PER_SEC - 1) / NS_PER_SEC);
+    long elapsed = (f->state == FRAME_DONE) ? total : (long)(f->elapsed_ns / NS_PER_SEC);
+
+    switch (kind) {
+    case SINK_BAR:
+        if (f->state != FRAME_INTERRUPTED) {
+            /* \r returns cursor to start of line */
+            fprintf(out, "\rElapsed: %4ld s | Remaining: %4ld s", elapsed, total - elapsed);
+            print_bar(out, f->elapsed_ns, f->total_ns);
+            fputs("    ", out);
+        }
+        if (f->state != FRAME_RUNNING) putc('\n', out);
+        break;
+    case SINK_LINES:
+        if (f->state == FRAME_INTERRUPTED) break;
+        fprintf(out, "Elapsed: %4ld s | Remaining: %4ld s", elapsed, total - elapsed);
+        print_bar(out, f->elapsed_ns, f->total_ns);
+        putc('\n', out);
+        break;
+    case SINK_JSONL:
+        fprintf(out, "{\"time\":%lld.%03lld,\"elapsed\":%.3f,\"remaining\":%.3f,\"total\":%.3f,\"state\":\"%s\"}\n",
+                f->wall_ns / NS_PER_SEC, f->wall_ns % NS_PER_SEC / 1000000, f->elapsed_ns / 1e9,
+                (f->total_ns - f->elapsed_ns) / 1e9, f->total_ns / 1e9, states[f->state]);
+        break;
+    case SINK_METRICS:
+        write_metrics(path, f);
+        return;
+    }
+    fflush(out);
+}
@@ -0,0 +1,34 @@
+/*
+* render.h
+*
+* Plain-text rendering of countdown frames, shared by sleeper and the
+* sleeper-render-bench microbenchmark.
+*/
+
+#ifndef SLEEPER_RENDER_H
+#define SLEEPER_RENDER_H
+
+#include <stdio.h>
+
+#define NS_PER_SEC 1000000000LL
+
+enum sink_kind { SINK_BAR, SINK_LINES, SINK_JSONL, SINK_METRICS };
+enum frame_state { FRAME_RUNNING, FRAME_DONE, FRAME_INTERRUPTED };
+
+/* A snapshot of the countdown as posted to a sink */
+struct frame {
+    long long elapsed_ns;
+    long long total_ns;
+    enum frame_state state;
+    long long wall_ns;      /* realtime the frame stands for, from the run's clock */
+};
+
+extern const char *const sink_names[];
+
+/* Renders the progress bar and percentage in plain text */
+void print_bar(FILE *out, long long elapsed, long long total);
+
+/* Renders one frame in the sink's format; metrics frames replace the file at path */
+void render_frame(FILE *out, enum sink_kind kind, const char *path, const struct frame *f);
+
+#endif
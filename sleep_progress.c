@@ -2,19 +2,61 @@
 * sleep_progress.c
 *
 * Usage:
-* ./sleep_progress <seconds> [--multiline] [--quiet]
+* ./sleep_progress <seconds> [--multiline] [--quiet] [--sink <spec>]... [--on <when>:<cmd>]...
+*                  [--speed <n>x | --dry-run]
+* ./sleep_progress --budget-remaining
+* ./sleep_progress --limit-pid <pid> --cpu <percent> [--period <duration>] [<seconds>]
+* ./sleep_progress --burn <threads> --duty <percent> [--period <duration>] [--duration <duration>]
+* ./sleep_progress --chaos-pid <pid> | --chaos-pgid <pgid> --pause <duration> --every <duration>
+*                  [--jitter <duration>] [--duration <duration>]
+* ./sleep_progress --heartbeat <duration> [--notify-socket <path>] [--heartbeat-file <path>]
+*                  [--heartbeat-offset <bytes>] [--liveness-file <path> --stall <duration>]
+*                  [--duration <duration>] -- <cmd> [args...]
+* ./sleep_progress --wait-cgroup <path> [--timeout <duration>] [--multiline] [--quiet]
 *
 * Behavior:
 * Prints start time and ETA once, then shows a clean progress bar.
+* --sink bar|lines|jsonl|metrics[:<path>][@<rate>] adds an output, each with its
+* own format and rate (e.g. bar@10hz, jsonl:run.jsonl@1s, metrics:m.prom@15s);
+* it replaces the default terminal bar that --multiline/--quiet select.
+* --on runs a shell command at a point of the countdown: <n>%, elapsed=<duration>,
+* remaining=<duration> or done. Hooks are spawned without blocking the timer.
+* --speed runs the countdown on a virtual clock <n> times faster than real time;
+* --dry-run does not wait at all and only reports the hooks it would start.
+* Both emit the same frames and timestamps the real run would.
+* With --limit-pid, caps another process's CPU share by alternately stopping
+* and continuing it on a fixed period, and shows achieved versus target use.
+* With --burn, runs pinned worker threads that alternate busy-work and sleeps
+* to generate a fixed CPU load, then reports measured per-core utilisation.
+* With --chaos-pid/--chaos-pgid, injects SIGSTOP/SIGCONT pauses of a precise
+* length at jittered intervals and logs each one with a timestamp.
+* With --heartbeat, runs a command and sends systemd-style WATCHDOG=1
+* datagrams (and/or rewrites a timestamp in a file) at exact intervals for
+* as long as it runs, withholding beats while its liveness file is stale.
+* With --wait-cgroup, returns as soon as a cgroup v2 tree has no processes
+* left; on --timeout the whole tree is killed through cgroup.kill (status 1
+* if it still has processes 5 s later). An inherited budget running out only
+* ends the wait with 124 and leaves the cgroup alone.
+* A run with a duration exports its absolute deadline as SLEEPER_DEADLINE_NS
+* (CLOCK_MONOTONIC nanoseconds) and caps that duration to any deadline it
+* inherited, so nested waits never outlive the outermost budget. Runs without
+* a duration, and --speed or --dry-run runs (whose time is not real time),
+* pass the inherited deadline on unchanged.
 * No ANSI colors for maximum compatibility with all terminals/logs.
 */
 
+#ifndef _WIN32
+    #define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <time.h>
 
+#include "render.h"
+
 #ifdef _WIN32
     #define WIN32_LEAN_AND_MEAN
     #include <windows.h>
@@ -32,13 +74,42 @@
     static int was_interrupted(void) {
         return (InterlockedCompareExchange(&interrupted, 1, 1) == 1);
     }
-    static int sleep_one_second(void) {
-        Sleep(1000);
-        return 0;
+
+    static long long now_ns(void) {
+        static LARGE_INTEGER freq;
+        LARGE_INTEGER count;
+        if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+        QueryPerformanceCounter(&count);
+        return (long long)(count.QuadPart / freq.QuadPart) * NS_PER_SEC
+             + (long long)(count.QuadPart % freq.QuadPart) * NS_PER_SEC / freq.QuadPart;
+    }
+    /* Sleeps until an absolute now_ns() deadline in short slices so Ctrl-C stays responsive */
+    static int sleep_until_ns(long long deadline) {
+        for (;;) {
+            long long left = deadline - now_ns();
+            if (left <= 0) return 0;
+            if (was_interrupted()) return -1;
+            Sleep((DWORD)(left > 100000000LL ? 100 : (left + 999999) / 1000000));
+        }
     }
 #else
     #include <signal.h>
     #include <unistd.h>
+    #include <poll.h>
+    #include <pthread.h>
+    #include <sys/types.h>
+    #ifdef __linux__
+        #include <fcntl.h>
+        #include <sched.h>
+        #include <spawn.h>
+        #include <stddef.h>
+        #include <sys/inotify.h>
+        #include <sys/socket.h>
+        #include <sys/stat.h>
+        #include <sys/syscall.h>
+        #include <sys/un.h>
+        #include <sys/wait.h>
+    #endif
 
     static volatile sig_atomic_t interrupted = 0;
     static void handle_sigint(int sig) {
@@ -52,42 +123,1364 @@
         sa.sa_flags = SA_RESTART;
         sigemptyset(&sa.sa_mask);
         sigaction(SIGINT, &sa, NULL);
+        /* Modes that stop other processes must get the chance to resume them, hangups included */
+        sigaction(SIGTERM, &sa, NULL);
+        sigaction(SIGHUP, &sa, NULL);
+        sigaction(SIGQUIT, &sa, NULL);
+    }
+    /* Blocks the signals install_handler catches, so helper threads leave them to the main thread */
+    static void block_stop_signals(sigset_t *old) {
+        sigset_t block;
+        sigemptyset(&block);
+        sigaddset(&block, SIGINT);
+        sigaddset(&block, SIGTERM);
+        sigaddset(&block, SIGHUP);
+        sigaddset(&block, SIGQUIT);
+        pthread_sigmask(SIG_BLOCK, &block, old);
     }
     static int was_interrupted(void) {
         return interrupted;
     }
-    static int sleep_one_second(void) {
-        struct timespec ts = { .tv_sec = 1, .tv_nsec = 0 };
-        while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {
+    static long long now_ns(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (long long)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+    }
+    #ifdef __linux__
+    /* Sleeps until an absolute CLOCK_MONOTONIC deadline, so periods never accumulate drift */
+    static int sleep_until_ns(long long deadline) {
+        struct timespec ts = { .tv_sec = deadline / NS_PER_SEC, .tv_nsec = deadline % NS_PER_SEC };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
             if (was_interrupted()) return -1;
         }
         return 0;
     }
+    #else
+    /* No clock_nanosleep (macOS): relative sleeps, re-aimed at the deadline after every wakeup */
+    static int sleep_until_ns(long long deadline) {
+        for (;;) {
+            long long left = deadline - now_ns();
+            if (left <= 0) return 0;
+            if (was_interrupted()) return -1;
+            struct timespec ts = { .tv_sec = left / NS_PER_SEC, .tv_nsec = left % NS_PER_SEC };
+            nanosleep(&ts, NULL);
+        }
+    }
+    #endif
+#endif
+
+/* Parses "<n>[ns|us|ms|s|m|h]" into nanoseconds; bare numbers are seconds. Returns -1 on error. */
+static long long parse_duration_ns(const char *s) {
+    char *end = NULL;
+    errno = 0;
+    double value = strtod(s, &end);
+    if (errno != 0 || end == s || value < 0) return -1;
+
+    double scale;
+    if (*end == '\0' || strcmp(end, "s") == 0) scale = 1e9;
+    else if (strcmp(end, "ns") == 0) scale = 1.0;
+    else if (strcmp(end, "us") == 0) scale = 1e3;
+    else if (strcmp(end, "ms") == 0) scale = 1e6;
+    else if (strcmp(end, "m") == 0) scale = 60e9;
+    else if (strcmp(end, "h") == 0) scale = 3600e9;
+    else return -1;
+    return (long long)(value * scale + 0.5);
+}
+
+/* Parses "<n>[%]" into a fraction in (0, 1], or [0, 1] with allow_zero. Returns -1 on error. */
+static double parse_percent(const char *s, int allow_zero) {
+    char *end = NULL;
+    errno = 0;
+    double value = strtod(s, &end);
+    if (errno != 0 || end == s || (*end != '\0' && strcmp(end, "%") != 0)) return -1;
+    if (value < 0 || (value == 0 && !allow_zero) || value > 100) return -1;
+    return value / 100.0;
+}
+
+/* Returns the value following an option, or NULL (with a message) if it is missing */
+static const char *option_value(int argc, char *argv[], int *i) {
+    if (*i + 1 >= argc) {
+        fprintf(stderr, "Error: %s requires a value.\n", argv[*i]);
+        return NULL;
+    }
+    return argv[++*i];
+}
+
+/*
+ * The countdown's clock. Everything the countdown, its sinks and its hooks do
+ * is timed through this interface, so a run can be replayed on a scaled
+ * virtual clock (--speed) or with no waiting at all (--dry-run) and still
+ * produce the same sequence of frames and hook events.
+ */
+struct sleeper_clock {
+    long long (*now)(struct sleeper_clock *clk);
+    int (*sleep_until)(struct sleeper_clock *clk, long long deadline);
+    double speed;           /* virtual seconds per real second; 0 for dry runs */
+    long long real_origin;  /* now_ns() when the clock started; virtual time starts here too */
+    long long wall_origin;  /* realtime ns when the clock started */
+    long long virtual_now;  /* dry runs only */
+};
+
+static long long real_clock_now(struct sleeper_clock *clk) {
+    (void)clk;
+    return now_ns();
+}
+
+static int real_clock_sleep_until(struct sleeper_clock *clk, long long deadline) {
+    (void)clk;
+    return sleep_until_ns(deadline);
+}
+
+static long long scaled_clock_now(struct sleeper_clock *clk) {
+    return clk->real_origin + (long long)((now_ns() - clk->real_origin) * clk->speed);
+}
+
+static int scaled_clock_sleep_until(struct sleeper_clock *clk, long long deadline) {
+    return sleep_until_ns(clk->real_origin + (long long)((deadline - clk->real_origin) / clk->speed));
+}
+
+static long long dry_clock_now(struct sleeper_clock *clk) {
+    return clk->virtual_now;
+}
+
+/* Dry runs never wait: virtual time jumps straight to the deadline */
+static int dry_clock_sleep_until(struct sleeper_clock *clk, long long deadline) {
+    if (was_interrupted()) return -1;
+    if (deadline > clk->virtual_now) clk->virtual_now = deadline;
+    return 0;
+}
+
+/* speed > 0 scales time (1 is real time); speed == 0 is a dry run */
+static void clock_init(struct sleeper_clock *clk, double speed) {
+    struct timespec wall;
+    timespec_get(&wall, TIME_UTC);
+    clk->speed = speed;
+    clk->real_origin = clk->virtual_now = now_ns();
+    clk->wall_origin = (long long)wall.tv_sec * NS_PER_SEC + wall.tv_nsec;
+    if (speed == 0) {
+        clk->now = dry_clock_now;
+        clk->sleep_until = dry_clock_sleep_until;
+    } else if (speed == 1) {
+        clk->now = real_clock_now;
+        clk->sleep_until = real_clock_sleep_until;
+    } else {
+        clk->now = scaled_clock_now;
+        clk->sleep_until = scaled_clock_sleep_until;
+    }
+}
+
+/* Wall-clock time (realtime ns) as seen on this clock */
+static long long clock_wall_ns(struct sleeper_clock *clk) {
+    return clk->wall_origin + (clk->now(clk) - clk->real_origin);
+}
+
+/*
+ * Wall time stamped on a frame: when it was actually posted on the real
+ * clock, the time it stands for on a virtual one (where "now" means nothing).
+ */
+static long long frame_wall_ns(struct sleeper_clock *clk, long long wall_start, long long offset) {
+    return (clk->speed == 1) ? clock_wall_ns(clk) : wall_start + offset;
+}
+
+/* Converts a span of this clock's time into real nanoseconds to wait */
+static long long clock_real_span(const struct sleeper_clock *clk, long long span) {
+    return (clk->speed > 0) ? (long long)(span / clk->speed) : 0;
+}
+
+/*
+ * Output pipeline for the countdown. The timing loop is the single event
+ * source: when a sink's next frame falls due it posts a small snapshot to that
+ * sink's mailbox. Each sink renders and writes on its own thread, so a slow
+ * file or terminal only ever delays itself. A full mailbox drops its oldest
+ * frame rather than blocking the timer; final frames are never dropped.
+ * Runs on a virtual clock make sinks lossless instead, since the point of
+ * those runs is to see every frame.
+ */
+#define SINK_RING 64
+
+struct sink {
+    enum sink_kind kind;
+    const char *path;
+    long long every_ns;
+    long long next_ns;
+    FILE *out;
+    unsigned long dropped;
+    int lossless;           /* virtual-clock runs must reproduce every frame */
+#ifndef _WIN32
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    pthread_cond_t space;
+    struct frame ring[SINK_RING];
+    unsigned head, tail;
+    int closing;
+#endif
+};
+
+/* Parses "<kind>[:<path>][@<rate>]"; <rate> is a duration or a frequency such as 10hz */
+static int parse_sink(const char *spec, struct sink *s) {
+    char kind[16];
+    size_t len = strcspn(spec, ":@");
+    if (len >= sizeof(kind)) return -1;
+    memcpy(kind, spec, len);
+    kind[len] = '\0';
+
+    memset(s, 0, sizeof(*s));
+    s->kind = SINK_BAR;
+    while (strcmp(kind, sink_names[s->kind]) != 0) {
+        if (s->kind == SINK_METRICS) return -1;
+        s->kind++;
+    }
+    s->every_ns = (s->kind == SINK_METRICS) ? 15 * NS_PER_SEC : NS_PER_SEC;
+
+    const char *rate = strrchr(spec + len, '@');
+    if (spec[len] == ':') {
+        size_t path_len = (size_t)((rate ? rate : spec + strlen(spec)) - (spec + len + 1));
+        char *path = malloc(path_len + 1);
+        if (!path) return -1;
+        memcpy(path, spec + len + 1, path_len);
+        path[path_len] = '\0';
+        s->path = path;
+    }
+    if (rate) {
+        size_t rate_len = strlen(rate + 1);
+        if (rate_len > 2 && (strcmp(rate + rate_len - 1, "hz") == 0 || strcmp(rate + rate_len - 1, "Hz") == 0)) {
+            char *end = NULL;
+            double hz = strtod(rate + 1, &end);
+            if (end != rate + rate_len - 1 || hz <= 0) return -1;
+            s->every_ns = (long long)(NS_PER_SEC / hz);
+        } else {
+            s->every_ns = parse_duration_ns(rate + 1);
+        }
+        if (s->every_ns <= 0) return -1;
+    }
+    if (s->kind == SINK_METRICS && (!s->path || strcmp(s->path, "-") == 0)) return -1;
+    return 0;
+}
+
+/* Metrics always write to their file; every other sink without a path writes to stdout */
+static int sink_on_stdout(const struct sink *s) {
+    return s->kind != SINK_METRICS && (!s->path || strcmp(s->path, "-") == 0);
+}
+
+static void sink_render(struct sink *s, const struct frame *f) {
+    render_frame(s->out, s->kind, s->path, f);
+}
+
+#ifndef _WIN32
+static void *sink_main(void *arg) {
+    struct sink *s = arg;
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while (s->head == s->tail && !s->closing) pthread_cond_wait(&s->ready, &s->lock);
+        if (s->head == s->tail) break;
+        struct frame f = s->ring[s->tail++ % SINK_RING];
+        pthread_cond_signal(&s->space);
+        pthread_mutex_unlock(&s->lock);
+        sink_render(s, &f);
+        pthread_mutex_lock(&s->lock);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+#endif
+
+static int sink_start(struct sink *s) {
+    if (s->kind == SINK_METRICS || sink_on_stdout(s)) {
+        s->out = stdout;
+    } else if (!(s->out = fopen(s->path, "a"))) {
+        fprintf(stderr, "Error: cannot open sink '%s': %s\n", s->path, strerror(errno));
+        return -1;
+    }
+#ifndef _WIN32
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->ready, NULL);
+    pthread_cond_init(&s->space, NULL);
+    /* Keep the stop signals on the main thread, where the countdown waits for them */
+    sigset_t old;
+    block_stop_signals(&old);
+    int rc = pthread_create(&s->thread, NULL, sink_main, s);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (rc != 0) {
+        fprintf(stderr, "Error: cannot start %s sink: %s\n", sink_names[s->kind], strerror(rc));
+        pthread_mutex_destroy(&s->lock);
+        pthread_cond_destroy(&s->ready);
+        pthread_cond_destroy(&s->space);
+        if (s->out != stdout) fclose(s->out);
+        s->out = NULL;
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+/*
+ * Posts a frame to the sink; only lossless sinks wait for room. Others drop
+ * their oldest queued frame, which is always a running one: the final frame
+ * is the last one posted.
+ */
+static void sink_post(struct sink *s, const struct frame *f) {
+#ifdef _WIN32
+    sink_render(s, f);
+#else
+    pthread_mutex_lock(&s->lock);
+    while (s->head - s->tail == SINK_RING) {
+        if (!s->lossless) {
+            s->tail++;
+            s->dropped++;
+        } else {
+            pthread_cond_wait(&s->space, &s->lock);
+        }
+    }
+    s->ring[s->head++ % SINK_RING] = *f;
+    pthread_cond_signal(&s->ready);
+    pthread_mutex_unlock(&s->lock);
+#endif
+}
+
+/* Drains and stops the sink's writer */
+static void sink_close(struct sink *s) {
+#ifndef _WIN32
+    pthread_mutex_lock(&s->lock);
+    s->closing = 1;
+    pthread_cond_signal(&s->ready);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->thread, NULL);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->ready);
+    pthread_cond_destroy(&s->space);
+#endif
+    if (s->out != stdout) fclose(s->out);
+    free((char *)s->path);
+    if (s->dropped > 0) {
+        fprintf(stderr, "Note: %s sink fell behind and skipped %lu frame%s.\n", sink_names[s->kind], s->dropped,
+                s->dropped == 1 ? "" : "s");
+    }
+}
+
+#ifdef __linux__
+/*
+ * A process (or process group) we send signals to. Holding a pidfd means a
+ * recycled PID can never receive our SIGSTOP; groups and kernels without
+ * pidfd support fall back to kill().
+ */
+struct target {
+    pid_t pid;
+    int pidfd;
+    int group;
+};
+
+static int target_open(struct target *t, pid_t pid, int group) {
+    t->pid = pid;
+    t->pidfd = -1;
+    t->group = group;
+    if (group) return kill(-pid, 0);
+#ifdef SYS_pidfd_open
+    t->pidfd = (int)syscall(SYS_pidfd_open, pid, 0);
+    if (t->pidfd >= 0) return 0;
+    if (errno != ENOSYS) return -1;
+#endif
+    return kill(pid, 0);
+}
+
+static int target_signal(const struct target *t, int sig) {
+#ifdef SYS_pidfd_send_signal
+    if (t->pidfd >= 0) return (int)syscall(SYS_pidfd_send_signal, t->pidfd, sig, NULL, 0);
+#endif
+    return kill(t->group ? -t->pid : t->pid, sig);
+}
+
+/* Returns 1 once the target has exited (a pidfd becomes readable at exit) */
+static int target_exited(const struct target *t) {
+    if (t->pidfd < 0) return kill(t->group ? -t->pid : t->pid, 0) != 0 && errno == ESRCH;
+    struct pollfd pfd = { .fd = t->pidfd, .events = POLLIN };
+    return poll(&pfd, 1, 0) > 0;
+}
+
+static void target_close(struct target *t) {
+    if (t->pidfd >= 0) close(t->pidfd);
+    t->pidfd = -1;
+}
+
+/* Waits for fd to become readable or the absolute deadline: 1 = readable, 0 = deadline, -1 = interrupted */
+static int wait_fd_until(int fd, long long deadline) {
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    for (;;) {
+        long long left = deadline - now_ns();
+        if (left <= 0) return 0;
+        struct timespec ts = { .tv_sec = left / NS_PER_SEC, .tv_nsec = left % NS_PER_SEC };
+        int rc = ppoll(&pfd, 1, &ts, NULL);
+        if (rc > 0) return 1;
+        if (rc < 0 && errno == EINTR && was_interrupted()) return -1;
+    }
+}
+
+/* Reads utime + stime (in clock ticks) from /proc/<pid>/stat */
+static int read_proc_cpu_ticks(pid_t pid, unsigned long long *ticks) {
+    char path[64], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+
+    /* comm may contain spaces and parentheses; fields resume after the last ')' */
+    char *p = strrchr(buf, ')');
+    unsigned long long utime, stime;
+    if (!p || sscanf(p + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+                     &utime, &stime) != 2) {
+        return -1;
+    }
+    *ticks = utime + stime;
+    return 0;
+}
+
+/*
+ * Duty-cycle throttling: each period starts with SIGCONT and ends its "on"
+ * share with SIGSTOP. Deadlines are absolute so the ratio holds over time.
+ */
+static int run_limit(pid_t pid, double share, long long period_ns, long long duration_ns,
+                     int multiline, int quiet) {
+    struct target t;
+    if (target_open(&t, pid, 0) != 0) {
+        fprintf(stderr, "Error: cannot attach to pid %d: %s\n", (int)pid, strerror(errno));
+        return 1;
+    }
+
+    const double ticks_per_sec = (double)sysconf(_SC_CLK_TCK);
+    unsigned long long start_ticks = 0, ticks = 0;
+    read_proc_cpu_ticks(pid, &start_ticks);
+
+    long long on_ns = (long long)(period_ns * share);
+    long long start = now_ns();
+    long long end = (duration_ns >= 0) ? start + duration_ns : -1;
+    long long cycle = start;
+    long long next_report = start;
+    double achieved = 0.0;
+    int status = 0;
+
+    printf("Limiting pid %d to %g%% CPU in %g ms periods", (int)pid, share * 100, period_ns / 1e6);
+    if (end >= 0) printf(" for %g s", duration_ns / 1e9);
+    printf("...\n");
+
+    for (;;) {
+        long long now = now_ns();
+        if (now >= next_report) {
+            if (read_proc_cpu_ticks(pid, &ticks) == 0 && now > start) {
+                achieved = (ticks - start_ticks) / ticks_per_sec / ((now - start) / 1e9);
+            }
+            if (!quiet) {
+                long elapsed = (long)((now - start) / NS_PER_SEC);
+                printf("%sElapsed: %4ld s | Target: %5.1f%% | Achieved: %5.1f%%",
+                       multiline ? "" : "\r", elapsed, share * 100, achieved * 100);
+                if (end >= 0) print_bar(stdout, elapsed, duration_ns / NS_PER_SEC);
+                printf(multiline ? "\n" : "    ");
+                fflush(stdout);
+            }
+            next_report += NS_PER_SEC;
+        }
+
+        if (end >= 0 && cycle >= end) break;
+        if (target_exited(&t) || target_signal(&t, SIGCONT) != 0) {
+            if (!quiet && !multiline) putchar('\n');
+            printf("Target pid %d exited.\n", (int)pid);
+            target_close(&t);
+            return 0;
+        }
+
+        long long stop_at = cycle + on_ns;
+        long long next_cycle = cycle + period_ns;
+        if (end >= 0 && stop_at > end) stop_at = end;
+        if (end >= 0 && next_cycle > end) next_cycle = end;
+
+        if (was_interrupted() || sleep_until_ns(stop_at) != 0) {
+            status = 130;
+            break;
+        }
+        if (stop_at < next_cycle) {
+            target_signal(&t, SIGSTOP);
+            if (sleep_until_ns(next_cycle) != 0) {
+                status = 130;
+                break;
+            }
+        }
+
+        /* If we fell behind (e.g. were descheduled), skip missed periods rather than bursting */
+        cycle += period_ns;
+        now = now_ns();
+        while (cycle + period_ns <= now) cycle += period_ns;
+    }
+
+    /* Never leave the target stopped behind us */
+    target_signal(&t, SIGCONT);
+    target_close(&t);
+
+    long long now = now_ns();
+    if (read_proc_cpu_ticks(pid, &ticks) == 0 && now > start) {
+        achieved = (ticks - start_ticks) / ticks_per_sec / ((now - start) / 1e9);
+    }
+
+    if (!quiet && !multiline) putchar('\n');
+    fflush(stdout);
+    if (status == 130) {
+        fprintf(stderr, "Interrupted. Achieved %.1f%% CPU (target %g%%).\n", achieved * 100, share * 100);
+    } else {
+        printf("Done. Achieved %.1f%% CPU (target %g%%).\n", achieved * 100, share * 100);
+    }
+    return status;
+}
+/* One --burn worker: pinned to a CPU, busy for on_ns out of every period_ns */
+struct burn_worker {
+    pthread_t thread;
+    int cpu;
+    long long on_ns;
+    long long period_ns;
+    long long start;
+    long long end;
+    double utilisation;
+};
+
+static long long thread_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (long long)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static void *burn_worker_main(void *arg) {
+    struct burn_worker *w = arg;
+    if (w->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(w->cpu, &set);
+        /* Read only after the join: the report must not credit a CPU we never got */
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) w->cpu = -1;
+    }
+
+    volatile unsigned long spin = 0;
+    sleep_until_ns(w->start);
+    long long cpu_start = thread_cpu_ns();
+
+    /*
+     * Busy-work is metered in consumed CPU time rather than wall time, so time
+     * lost to preemption or steal is made up within the same period.
+     */
+    long long owed = 0;
+    long long cycle = w->start;
+    while ((w->end < 0 || cycle < w->end) && !was_interrupted()) {
+        long long next_cycle = cycle + w->period_ns;
+        if (w->end >= 0 && next_cycle > w->end) next_cycle = w->end;
+        owed += (long long)((double)w->on_ns * (next_cycle - cycle) / w->period_ns);
+
+        while (thread_cpu_ns() - cpu_start < owed && now_ns() < next_cycle) {
+            for (int i = 0; i < 1024; ++i) spin++;
+        }
+        if (sleep_until_ns(next_cycle) != 0) break;
+
+        /* Periods missed entirely are dropped, not repaid in one burst */
+        cycle += w->period_ns;
+        long long now = now_ns();
+        while (cycle + w->period_ns <= now) cycle += w->period_ns;
+        if (thread_cpu_ns() - cpu_start < owed - w->on_ns) owed = thread_cpu_ns() - cpu_start + w->on_ns;
+    }
+
+    long long wall = now_ns() - w->start;
+    w->utilisation = (wall > 0) ? (double)(thread_cpu_ns() - cpu_start) / wall : 0.0;
+    return NULL;
+}
+
+/* Synthetic load: N pinned workers sharing one absolute period grid */
+static int run_burn(int threads, double duty, long long period_ns, long long duration_ns,
+                    int multiline, int quiet) {
+    struct burn_worker *workers = calloc((size_t)threads, sizeof(*workers));
+    if (!workers) {
+        fprintf(stderr, "Error: out of memory.\n");
+        return 1;
+    }
+
+    /* Pin round-robin over the CPUs we are allowed to run on */
+    cpu_set_t allowed;
+    int cpus[CPU_SETSIZE], ncpus = 0;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &allowed)) cpus[ncpus++] = c;
+        }
+    }
+
+    /* Workers leave signals to the main thread, which owns the progress bar */
+    sigset_t old;
+    block_stop_signals(&old);
+
+    /* A shared start slightly in the future keeps every worker's periods in phase */
+    long long start = now_ns() + 10000000LL;
+    long long end = (duration_ns >= 0) ? start + duration_ns : -1;
+    int started = 0;
+    for (; started < threads; ++started) {
+        struct burn_worker *w = &workers[started];
+        w->cpu = (ncpus > 0) ? cpus[started % ncpus] : -1;
+        w->on_ns = (long long)(period_ns * duty);
+        w->period_ns = period_ns;
+        w->start = start;
+        w->end = end;
+        int rc = pthread_create(&w->thread, NULL, burn_worker_main, w);
+        if (rc != 0) {
+            fprintf(stderr, "Error: cannot start worker %d: %s\n", started, strerror(rc));
+            break;
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    printf("Burning %d thread%s at %g%% duty in %g ms periods", started, started == 1 ? "" : "s",
+           duty * 100, period_ns / 1e6);
+    if (end >= 0) printf(" for %g s", duration_ns / 1e9);
+    printf("...\n");
+
+    long total = (end >= 0) ? (long)((duration_ns + NS_PER_SEC - 1) / NS_PER_SEC) : -1;
+    long elapsed = 0;
+    int status = (started == threads) ? 0 : 1;
+    while (started > 0) {
+        if (!quiet) {
+            if (total >= 0) {
+                printf("%sElapsed: %4ld s | Remaining: %4ld s", multiline ? "" : "\r", elapsed, total - elapsed);
+                print_bar(stdout, elapsed, total);
+            } else {
+                printf("%sElapsed: %4ld s", multiline ? "" : "\r", elapsed);
+            }
+            printf(multiline ? "\n" : "    ");
+            fflush(stdout);
+        }
+        if (total >= 0 && elapsed >= total) break;
+
+        long long next = start + (elapsed + 1) * NS_PER_SEC;
+        if (end >= 0 && next > end) next = end;
+        if (was_interrupted() || sleep_until_ns(next) != 0 || was_interrupted()) {
+            status = 130;
+            break;
+        }
+        elapsed++;
+    }
+
+    for (int i = 0; i < started; ++i) pthread_join(workers[i].thread, NULL);
+
+    if (!quiet && !multiline) putchar('\n');
+    fflush(stdout);
+    if (status == 130) fprintf(stderr, "Interrupted at %ld s.\n", elapsed);
+    /* Workers sharing a core add up to that core's utilisation; unpinned ones roam */
+    for (int c = 0; c <= ncpus; ++c) {
+        int cpu = (c < ncpus) ? cpus[c] : -1, count = 0;
+        double used = 0;
+        for (int i = 0; i < started; ++i) {
+            if (workers[i].cpu != cpu) continue;
+            used += workers[i].utilisation;
+            count++;
+        }
+        if (count == 0) continue;
+        if (cpu >= 0) printf("CPU %d: %5.1f%%", cpu, used * 100);
+        else printf("Unpinned: %5.1f%% of one CPU", used * 100);
+        printf(" (%d worker%s)\n", count, count == 1 ? "" : "s");
+    }
+    free(workers);
+    return status;
+}
+/* xorshift64*: plenty for spreading pauses, and needs no global state */
+static unsigned long long next_random(unsigned long long *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+/* Formats a CLOCK_REALTIME timestamp as HH:MM:SS.mmm for log lines */
+static void format_log_time(const struct timespec *ts, char *buf, size_t size) {
+    time_t secs = ts->tv_sec;
+    struct tm tm;
+    localtime_r(&secs, &tm);
+    size_t n = strftime(buf, size, "%H:%M:%S", &tm);
+    snprintf(buf + n, size - n, ".%03ld", ts->tv_nsec / 1000000);
+}
+
+/*
+ * Pause injection: pause k nominally starts at start + k * every, shifted by a
+ * uniform offset in [-jitter, +jitter]. Anchoring to the grid keeps the mean
+ * rate exact no matter how the offsets fall.
+ */
+static int run_chaos(pid_t pid, int group, long long pause_ns, long long every_ns, long long jitter_ns,
+                     long long duration_ns, int quiet) {
+    struct target t;
+    if (target_open(&t, pid, group) != 0) {
+        fprintf(stderr, "Error: cannot attach to %s %d: %s\n", group ? "process group" : "pid", (int)pid,
+                strerror(errno));
+        return 1;
+    }
+
+    const char *what = group ? "process group" : "pid";
+    unsigned long long rng = (unsigned long long)now_ns() ^ ((unsigned long long)getpid() << 32);
+    long long start = now_ns();
+    long long end = (duration_ns >= 0) ? start + duration_ns : -1;
+    long long prev_end = start;
+    long long count = 0;
+    double worst_error = 0.0, total_error = 0.0;
+    int status = 0;
+
+    printf("Injecting %g ms pauses into %s %d every %g s", pause_ns / 1e6, what, (int)pid, every_ns / 1e9);
+    if (jitter_ns > 0) printf(" (+/- %g s)", jitter_ns / 1e9);
+    if (end >= 0) printf(" for %g s", duration_ns / 1e9);
+    printf("...\n");
+    fflush(stdout);
+
+    for (long long k = 1;; ++k) {
+        long long at = start + k * every_ns;
+        if (jitter_ns > 0) at += (long long)(next_random(&rng) % (unsigned long long)(2 * jitter_ns + 1)) - jitter_ns;
+        if (at < prev_end) at = prev_end;
+        if (end >= 0 && at + pause_ns > end) break;
+
+        if (sleep_until_ns(at) != 0) {
+            status = 130;
+            break;
+        }
+        if (target_exited(&t)) {
+            printf("Target %s %d exited.\n", what, (int)pid);
+            break;
+        }
+
+        struct timespec wall_stopped;
+        clock_gettime(CLOCK_REALTIME, &wall_stopped);
+        long long stopped = now_ns();
+        if (target_signal(&t, SIGSTOP) != 0) {
+            printf("Target %s %d exited.\n", what, (int)pid);
+            break;
+        }
+        int interrupted_now = sleep_until_ns(stopped + pause_ns) != 0;
+        target_signal(&t, SIGCONT);
+        long long resumed = now_ns();
+        prev_end = resumed;
+
+        double actual_ms = (resumed - stopped) / 1e6;
+        double error_ms = actual_ms - pause_ns / 1e6;
+        if (error_ms > worst_error) worst_error = error_ms;
+        total_error += error_ms;
+        count++;
+
+        if (!quiet) {
+            char stamp[32];
+            format_log_time(&wall_stopped, stamp, sizeof(stamp));
+            printf("[%s] pause #%lld: %.3f ms (requested %g ms, start late by %.3f ms)\n", stamp, count,
+                   actual_ms, pause_ns / 1e6, (stopped - at) / 1e6);
+            fflush(stdout);
+        }
+        if (interrupted_now) {
+            status = 130;
+            break;
+        }
+    }
+
+    target_close(&t);
+    if (status == 130) fprintf(stderr, "Interrupted.\n");
+    printf("Injected %lld pause%s", count, count == 1 ? "" : "s");
+    if (count > 0) printf(", mean overshoot %.3f ms, worst %.3f ms", total_error / count, worst_error);
+    printf(".\n");
+    return status;
+}
+/* Converts a waitpid() status into the exit code a shell would report */
+static int exit_code_of(int wstatus) {
+    if (WIFEXITED(wstatus)) return WEXITSTATUS(wstatus);
+    if (WIFSIGNALED(wstatus)) return 128 + WTERMSIG(wstatus);
+    return 1;
+}
+
+/*
+ * Beat destinations. Everything a beat needs is prepared up front so that each
+ * beat costs one sendto() and/or one pwrite() of a fixed-size record.
+ */
+struct heartbeat {
+    int sock;
+    struct sockaddr_un addr;
+    socklen_t addr_len;
+    int file_fd;
+    off_t file_offset;
+    unsigned long failed;   /* beats that did not reach a destination */
+};
+
+static const char watchdog_message[] = "WATCHDOG=1";
+
+static int heartbeat_open(struct heartbeat *hb, const char *notify_socket, const char *file, off_t offset) {
+    hb->sock = -1;
+    hb->file_fd = -1;
+    hb->file_offset = offset;
+    hb->failed = 0;
+
+    if (notify_socket) {
+        size_t len = strlen(notify_socket);
+        if (len == 0 || len >= sizeof(hb->addr.sun_path)) {
+            fprintf(stderr, "Error: invalid notify socket path '%s'.\n", notify_socket);
+            return -1;
+        }
+        memset(&hb->addr, 0, sizeof(hb->addr));
+        hb->addr.sun_family = AF_UNIX;
+        memcpy(hb->addr.sun_path, notify_socket, len);
+        /* systemd spells abstract-namespace sockets with a leading '@' */
+        if (hb->addr.sun_path[0] == '@') hb->addr.sun_path[0] = '\0';
+        hb->addr_len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + len);
+        hb->sock = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (hb->sock < 0) {
+            fprintf(stderr, "Error: cannot create notify socket: %s\n", strerror(errno));
+            return -1;
+        }
+    }
+    if (file) {
+        hb->file_fd = open(file, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        if (hb->file_fd < 0) {
+            fprintf(stderr, "Error: cannot open heartbeat file '%s': %s\n", file, strerror(errno));
+            if (hb->sock >= 0) close(hb->sock);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* The first failure is reported as it happens; later ones are only counted */
+static void heartbeat_failed(struct heartbeat *hb, const char *what) {
+    if (hb->failed++ == 0) {
+        fprintf(stderr, "Heartbeat %s failed: %s (further failures are counted).\n", what, strerror(errno));
+    }
+}
+
+static void heartbeat_beat(struct heartbeat *hb) {
+    if (hb->sock >= 0) {
+        if (sendto(hb->sock, watchdog_message, sizeof(watchdog_message) - 1, MSG_DONTWAIT | MSG_NOSIGNAL,
+                   (const struct sockaddr *)&hb->addr, hb->addr_len) < 0) {
+            heartbeat_failed(hb, "datagram");
+        }
+    }
+    if (hb->file_fd >= 0) {
+        /* Fixed width, so every beat overwrites the previous record in place */
+        char record[21];
+        struct timespec ts;
+        errno = 0;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        snprintf(record, sizeof(record), "%019lld\n", (long long)ts.tv_sec * NS_PER_SEC + ts.tv_nsec);
+        if (pwrite(hb->file_fd, record, sizeof(record) - 1, hb->file_offset) != (ssize_t)(sizeof(record) - 1)) {
+            if (errno == 0) errno = EIO;
+            heartbeat_failed(hb, "file write");
+        }
+    }
+}
+
+static void heartbeat_close(struct heartbeat *hb) {
+    if (hb->sock >= 0) close(hb->sock);
+    if (hb->file_fd >= 0) close(hb->file_fd);
+    hb->sock = hb->file_fd = -1;
+    if (hb->failed > 1) fprintf(stderr, "Heartbeat: %lu beat writes failed in total.\n", hb->failed);
+}
+
+/* A command counts as stalled once its liveness file has not been touched for stall_ns */
+static int liveness_stalled(const char *path, long long stall_ns) {
+    struct stat st;
+    struct timespec now;
+    if (stat(path, &st) != 0) return 1;
+    clock_gettime(CLOCK_REALTIME, &now);
+    long long age = (long long)(now.tv_sec - st.st_mtim.tv_sec) * NS_PER_SEC + (now.tv_nsec - st.st_mtim.tv_nsec);
+    return age > stall_ns;
+}
+
+/*
+ * Heartbeat: beat on an absolute grid until the wrapped command exits, then
+ * return its status. With a deadline the command is terminated when it passes.
+ */
+static int run_heartbeat(long long interval_ns, struct heartbeat *hb, const char *liveness_file,
+                         long long stall_ns, long long duration_ns, char *const cmd[]) {
+    pid_t pid;
+    int rc = posix_spawnp(&pid, cmd[0], NULL, NULL, cmd, environ);
+    if (rc != 0) {
+        fprintf(stderr, "Error: cannot run '%s': %s\n", cmd[0], strerror(rc));
+        return 127;
+    }
+
+    /* Our own unreaped child, so its pid cannot be recycled under us */
+    struct target child;
+    if (target_open(&child, pid, 0) != 0) child.pidfd = -1;
+
+    long long next = now_ns();
+    long long end = (duration_ns >= 0) ? next + duration_ns : -1;
+    int stalled = 0, timed_out = 0, aborted = 0;
+    int wstatus = 0, reaped = 0;
+    for (;;) {
+        int now_stalled = liveness_file && liveness_stalled(liveness_file, stall_ns);
+        if (now_stalled != stalled) {
+            fprintf(stderr, now_stalled ? "Command stalled: withholding heartbeats.\n"
+                                        : "Command alive again: resuming heartbeats.\n");
+            stalled = now_stalled;
+        }
+        if (!stalled) heartbeat_beat(hb);
+
+        next += interval_ns;
+        long long now = now_ns();
+        while (next <= now) next += interval_ns;
+
+        /* Without a pidfd, exit is noticed by polling waitpid() every 100ms */
+        if (end >= 0 && next > end) next = end;
+        int woke;
+        do {
+            long long wake = next;
+            if (child.pidfd < 0 && wake > now_ns() + 100000000LL) wake = now_ns() + 100000000LL;
+            woke = wait_fd_until(child.pidfd, wake);
+            if (woke == 0 && child.pidfd < 0 && waitpid(pid, &wstatus, WNOHANG) == pid) {
+                reaped = 1;
+                woke = 1;
+            }
+        } while (woke == 0 && now_ns() < next);
+
+        if (woke < 0) {
+            fprintf(stderr, "Interrupted: terminating '%s'.\n", cmd[0]);
+            target_signal(&child, SIGTERM);
+            aborted = 1;
+            break;
+        }
+        if (woke > 0) break;
+        if (end >= 0 && next >= end) {
+            fprintf(stderr, "Deadline reached: terminating '%s'.\n", cmd[0]);
+            target_signal(&child, SIGTERM);
+            timed_out = 1;
+            break;
+        }
+    }
+
+    while (!reaped && waitpid(pid, &wstatus, 0) < 0 && errno == EINTR) {}
+    target_close(&child);
+    /* Like timeout(1), a command we had to stop reports 124; an interrupted run reports 130 */
+    if (aborted) return 130;
+    return timed_out ? 124 : exit_code_of(wstatus);
+}
+/* Reads the "populated" flag from <cgroup>/cgroup.events: 1, 0, or -1 on error */
+static int read_cgroup_populated(const char *cgroup) {
+    char path[4096], line[128];
+    snprintf(path, sizeof(path), "%s/cgroup.events", cgroup);
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int populated = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "populated %d", &populated) == 1) break;
+    }
+    fclose(f);
+    return populated;
+}
+
+/* Counts the processes listed in <cgroup>/cgroup.procs */
+static long count_cgroup_procs(const char *cgroup) {
+    char path[4096], buf[4096];
+    snprintf(path, sizeof(path), "%s/cgroup.procs", cgroup);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    long lines = 0;
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < n; ++i) lines += (buf[i] == '\n');
+    }
+    close(fd);
+    return lines;
+}
+
+/* Kills every process in the cgroup and its descendants with one write (Linux 5.14+) */
+static int kill_cgroup(const char *cgroup) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/cgroup.kill", cgroup);
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    int rc = (write(fd, "1", 1) == 1) ? 0 : -1;
+    close(fd);
+    return rc;
+}
+
+static void drain_inotify(int fd) {
+    char events[4096];
+    while (read(fd, events, sizeof(events)) > 0) {}
+}
+
+/*
+ * Waits for a cgroup to drain. The kernel rewrites cgroup.events when the
+ * populated flag flips, so an inotify watch wakes us the moment the last
+ * process leaves; cgroup.procs is only read when the bar is redrawn.
+ * Only an explicit timeout (duration_ns) kills the tree; an inherited
+ * deadline just stops waiting.
+ */
+static int run_wait_cgroup(const char *cgroup, long long duration_ns, long long inherited_deadline, int multiline,
+                           int quiet) {
+    char events_path[4096];
+    snprintf(events_path, sizeof(events_path), "%s/cgroup.events", cgroup);
+
+    int ino = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (ino < 0 || inotify_add_watch(ino, events_path, IN_MODIFY) < 0) {
+        fprintf(stderr, "Error: cannot watch '%s': %s\n", events_path, strerror(errno));
+        if (ino >= 0) close(ino);
+        return 1;
+    }
+
+    /* Whichever limit comes first ends the wait, but only our own timeout kills */
+    long long start = now_ns();
+    long long kill_at = (duration_ns >= 0) ? start + duration_ns : -1;
+    long long end = kill_at;
+    if (inherited_deadline >= 0 && (end < 0 || inherited_deadline < end)) end = inherited_deadline;
+    if (end >= 0 && end < start) end = start;
+    int kills = (kill_at >= 0 && end == kill_at);
+    long long span = (end >= 0) ? end - start : -1;
+    long total = (end >= 0) ? (long)((span + NS_PER_SEC - 1) / NS_PER_SEC) : -1;
+    long long next_refresh = start;
+    int status = 0;
+
+    printf("Waiting for cgroup %s to drain", cgroup);
+    if (kills) printf(" (timeout %g s)", duration_ns / 1e9);
+    else if (end >= 0) printf(" (inherited budget %.3f s)", span / 1e9);
+    printf("...\n");
+
+    /* Read only after arming the watch, so an exit in between cannot be missed */
+    int populated = read_cgroup_populated(cgroup);
+    while (populated != 0) {
+        if (populated < 0) {
+            fprintf(stderr, "Error: cannot read '%s': %s\n", events_path, strerror(errno));
+            status = 1;
+            break;
+        }
+
+        long long now = now_ns();
+        if (now >= next_refresh) {
+            if (!quiet) {
+                long long shown = (end >= 0 && now > end) ? end - start : now - start;
+                long elapsed = (long)(shown / NS_PER_SEC);
+                printf("%sElapsed: %4ld s", multiline ? "" : "\r", elapsed);
+                if (total >= 0) printf(" | Remaining: %4ld s", total - elapsed);
+                printf(" | Processes: %4ld", count_cgroup_procs(cgroup));
+                if (total >= 0) print_bar(stdout, shown, span);
+                printf(multiline ? "\n" : "    ");
+                fflush(stdout);
+            }
+            next_refresh += NS_PER_SEC;
+            while (next_refresh <= now) next_refresh += NS_PER_SEC;
+        }
+        if (end >= 0 && now >= end) {
+            status = 124;
+            break;
+        }
+
+        long long wake = (end >= 0 && end < next_refresh) ? end : next_refresh;
+        int woke = wait_fd_until(ino, wake);
+        if (woke < 0) {
+            status = 130;
+            break;
+        }
+        if (woke > 0) {
+            drain_inotify(ino);
+            populated = read_cgroup_populated(cgroup);
+        }
+    }
+
+    if (!quiet && !multiline && next_refresh > start) putchar('\n');
+    fflush(stdout);
+    if (status == 0) {
+        printf("Cgroup drained after %.3f s.\n", (now_ns() - start) / 1e9);
+    } else if (status == 124 && !kills) {
+        fprintf(stderr, "Inherited budget ran out after %.3f s; the cgroup was left running.\n",
+                (now_ns() - start) / 1e9);
+    } else if (status == 124) {
+        /* One write tears down the whole tree, daemonized grandchildren included */
+        if (kill_cgroup(cgroup) != 0) {
+            fprintf(stderr, "Timed out; cannot write cgroup.kill: %s\n", strerror(errno));
+            status = 1;
+        } else {
+            long long deadline = now_ns() + 5 * NS_PER_SEC;
+            while ((populated = read_cgroup_populated(cgroup)) == 1) {
+                if (wait_fd_until(ino, deadline) <= 0) {
+                    /* Grace period over (or interrupted): one last look before reporting */
+                    populated = read_cgroup_populated(cgroup);
+                    break;
+                }
+                drain_inotify(ino);
+            }
+            if (populated == 0) {
+                fprintf(stderr, "Timed out after %.3f s; killed every process in the cgroup.\n", duration_ns / 1e9);
+            } else {
+                fprintf(stderr, "Timed out after %.3f s; cgroup.kill was written but %ld processes remain.\n",
+                        duration_ns / 1e9, count_cgroup_procs(cgroup));
+                status = 1;
+            }
+        }
+    } else if (status == 130) {
+        fprintf(stderr, "Interrupted; the cgroup was left running.\n");
+    }
+    close(ino);
+    return status;
+}
+
+/* A --on hook: a shell command fired at a fixed offset into the countdown */
+enum hook_when { HOOK_PERCENT, HOOK_ELAPSED, HOOK_REMAINING, HOOK_DONE };
+
+struct hook {
+    enum hook_when when;
+    double value;
+    const char *cmd;
+    long long at_ns;
+    int fired;
+    pid_t pid;
+    int pidfd;
+};
+
+/* Parses "<when>:<cmd>" where <when> is <n>%, elapsed=<duration>, remaining=<duration> or done */
+static int parse_hook(const char *spec, struct hook *h) {
+    const char *colon = strchr(spec, ':');
+    if (!colon || colon[1] == '\0') return -1;
+
+    char when[64];
+    size_t len = (size_t)(colon - spec);
+    if (len >= sizeof(when)) return -1;
+    memcpy(when, spec, len);
+    when[len] = '\0';
+
+    memset(h, 0, sizeof(*h));
+    h->cmd = colon + 1;
+    h->pidfd = -1;
+    if (strcmp(when, "done") == 0) {
+        h->when = HOOK_DONE;
+    } else if (strncmp(when, "elapsed=", 8) == 0) {
+        h->when = HOOK_ELAPSED;
+        h->value = (double)parse_duration_ns(when + 8);
+    } else if (strncmp(when, "remaining=", 10) == 0) {
+        h->when = HOOK_REMAINING;
+        h->value = (double)parse_duration_ns(when + 10);
+    } else {
+        h->when = HOOK_PERCENT;
+        h->value = parse_percent(when, 1);
+    }
+    return (h->value < 0) ? -1 : 0;
+}
+
+/* Resolves each hook to an offset from the start once the final duration is known */
+static void resolve_hooks(struct hook *hooks, int count, long long duration_ns) {
+    for (int i = 0; i < count; ++i) {
+        struct hook *h = &hooks[i];
+        switch (h->when) {
+        case HOOK_PERCENT: h->at_ns = (long long)(duration_ns * h->value); break;
+        case HOOK_ELAPSED: h->at_ns = (long long)h->value; break;
+        case HOOK_REMAINING: h->at_ns = duration_ns - (long long)h->value; break;
+        case HOOK_DONE: h->at_ns = duration_ns; break;
+        }
+        if (h->at_ns < 0) h->at_ns = 0;
+        if (h->at_ns > duration_ns) h->at_ns = duration_ns;
+    }
+}
+
+/* Launches a hook via posix_spawn; the timing loop never waits for it */
+static void fire_hook(struct hook *h, int dry_run) {
+    if (dry_run) {
+        /* stderr keeps these apart from the sinks, one of which may be on stdout */
+        fprintf(stderr, "Hook at %.3f s (dry run, not started): %s\n", h->at_ns / 1e9, h->cmd);
+        h->fired = 1;
+        return;
+    }
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    /* A group of its own lets an interrupted countdown stop the whole hook */
+    short flags = POSIX_SPAWN_SETPGROUP;
+#ifdef POSIX_SPAWN_USEVFORK
+    flags |= POSIX_SPAWN_USEVFORK;
 #endif
+    posix_spawnattr_setflags(&attr, flags);
+    posix_spawnattr_setpgroup(&attr, 0);
+    char *argv[] = { "sh", "-c", (char *)h->cmd, NULL };
+    int rc = posix_spawn(&h->pid, "/bin/sh", NULL, &attr, argv, environ);
+    posix_spawnattr_destroy(&attr);
+
+    h->fired = 1;
+    if (rc != 0) {
+        fprintf(stderr, "Hook '%s' failed to start: %s\n", h->cmd, strerror(rc));
+        h->pid = 0;
+        return;
+    }
+#ifdef SYS_pidfd_open
+    h->pidfd = (int)syscall(SYS_pidfd_open, h->pid, 0);
+#endif
+}
+
+/* Collects an exited hook and reports failures; non-blocking unless asked to wait */
+static int reap_hook(struct hook *h, int block) {
+    int wstatus;
+    pid_t r;
+    while ((r = waitpid(h->pid, &wstatus, block ? 0 : WNOHANG)) < 0 && errno == EINTR) {}
+    if (r == 0) return 0;
+    if (r == h->pid && exit_code_of(wstatus) != 0) {
+        fprintf(stderr, "Hook '%s' exited with status %d.\n", h->cmd, exit_code_of(wstatus));
+    }
+    if (h->pidfd >= 0) close(h->pidfd);
+    h->pidfd = -1;
+    h->pid = 0;
+    return 1;
+}
+
+/*
+ * Sleeps until an absolute deadline while firing hooks that fall due on the way
+ * and reaping finished ones through their pidfds. Returns -1 if interrupted.
+ */
+static int hooks_wait_until(struct sleeper_clock *clk, struct hook *hooks, int count, long long start,
+                            long long deadline) {
+    for (;;) {
+        long long now = clk->now(clk);
+        long long wake = deadline;
+        struct pollfd fds[64];
+        int nfds = 0, polling_slowly = 0;
+
+        for (int i = 0; i < count; ++i) {
+            struct hook *h = &hooks[i];
+            if (!h->fired && h->when != HOOK_DONE) {
+                if (start + h->at_ns <= now) fire_hook(h, clk->speed == 0);
+                else if (start + h->at_ns < wake) wake = start + h->at_ns;
+            }
+            if (h->pid > 0) {
+                if (h->pidfd >= 0 && nfds < (int)(sizeof(fds) / sizeof(fds[0]))) {
+                    fds[nfds].fd = h->pidfd;
+                    fds[nfds].events = POLLIN;
+                    fds[nfds].revents = 0;
+                    nfds++;
+                } else {
+                    reap_hook(h, 0);
+                    polling_slowly = 1;
+                }
+            }
+        }
+        if (now >= deadline) return 0;
 
-/* Renders the progress bar and percentage in plain text */
-static void print_bar(long elapsed, long total) {
-    const int BAR_WIDTH = 20;
-    float percentage = (total == 0) ? 1.0f : (float)elapsed / total;
-    int filled_width = (int)(percentage * BAR_WIDTH);
+        /* Nothing to watch: a plain absolute sleep is the most precise wait */
+        if (nfds == 0 && !polling_slowly) {
+            if (clk->sleep_until(clk, wake) != 0) return -1;
+            continue;
+        }
+
+        long long left = clock_real_span(clk, wake - now);
+        if (polling_slowly && left > 100000000LL) left = 100000000LL;
+        struct timespec ts = { .tv_sec = left / NS_PER_SEC, .tv_nsec = left % NS_PER_SEC };
+        int rc = ppoll(fds, (nfds_t)nfds, &ts, NULL);
+        if (rc < 0 && errno == EINTR && was_interrupted()) return -1;
+        for (int i = 0; rc > 0 && i < count; ++i) {
+            struct hook *h = &hooks[i];
+            for (int j = 0; h->pid > 0 && j < nfds; ++j) {
+                if (fds[j].fd == h->pidfd && (fds[j].revents & POLLIN)) reap_hook(h, 0);
+            }
+        }
+    }
+}
+
+/* Fires the done hooks, then waits for every hook still running. Returns -1 if interrupted. */
+static int hooks_finish(struct hook *hooks, int count, int dry_run) {
+    for (int i = 0; i < count; ++i) {
+        if (!hooks[i].fired) fire_hook(&hooks[i], dry_run);
+    }
+    for (int i = 0; i < count; ++i) {
+        struct hook *h = &hooks[i];
+        /* A blocking waitpid() would restart through SA_RESTART and never see Ctrl-C */
+        while (h->pid > 0 && !reap_hook(h, 0)) {
+            long long wake = now_ns() + (h->pidfd >= 0 ? NS_PER_SEC : 100000000LL);
+            if (was_interrupted() || wait_fd_until(h->pidfd, wake) < 0) return -1;
+        }
+    }
+    return 0;
+}
 
-    printf(" [");
-    for (int i = 0; i < BAR_WIDTH; ++i) {
-        if (i < filled_width) putchar('#');
-        else putchar('-');
+/* On interrupt: pending hooks never fire, running ones get SIGTERM and are reaped */
+static void hooks_abort(struct hook *hooks, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (hooks[i].pid > 0) kill(-hooks[i].pid, SIGTERM);
+    }
+    for (int i = 0; i < count; ++i) {
+        struct hook *h = &hooks[i];
+        if (h->pid <= 0) continue;
+        while (waitpid(h->pid, NULL, 0) < 0 && errno == EINTR) {}
+        if (h->pidfd >= 0) close(h->pidfd);
+        h->pidfd = -1;
+        h->pid = 0;
     }
-    printf("] %3d%%", (int)(percentage * 100));
+}
+#endif
+
+#define DEADLINE_ENV "SLEEPER_DEADLINE_NS"
+
+/* Returns the absolute deadline inherited from an enclosing sleeper, or -1 if there is none */
+static long long inherited_deadline_ns(void) {
+    const char *v = getenv(DEADLINE_ENV);
+    if (!v || !*v) return -1;
+    char *end = NULL;
+    errno = 0;
+    long long deadline = strtoll(v, &end, 10);
+    if (errno != 0 || *end != '\0' || deadline < 0) return -1;
+    return deadline;
+}
+
+/* Publishes our deadline to everything we spawn */
+static void export_deadline_ns(long long deadline) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lld", deadline);
+#ifdef _WIN32
+    _putenv_s(DEADLINE_ENV, buf);
+#else
+    setenv(DEADLINE_ENV, buf, 1);
+#endif
 }
 
 int main(int argc, char *argv[]) {
     if (argc < 2) {
-        fprintf(stderr, "Usage: %s <seconds> [--multiline] [--quiet]\n", argv[0]);
+        fprintf(stderr, "Usage: %s <seconds> [--multiline] [--quiet] [--sink <spec>]... [--on <when>:<cmd>]..."
+                " [--speed <n>x | --dry-run]\n", argv[0]);
+        fprintf(stderr, "       %s --budget-remaining\n", argv[0]);
+        fprintf(stderr, "       %s --limit-pid <pid> --cpu <percent> [--period <duration>] [<seconds>]\n",
+                argv[0]);
+        fprintf(stderr, "       %s --chaos-pid <pid> | --chaos-pgid <pgid> --pause <duration> --every <duration>"
+                " [--jitter <duration>] [--duration <duration>]\n", argv[0]);
+        fprintf(stderr, "       %s --heartbeat <duration> [--notify-socket <path>] [--heartbeat-file <path>]"
+                " [--heartbeat-offset <bytes>] [--liveness-file <path> --stall <duration>] [--duration <duration>]"
+                " -- <cmd> [args...]\n",
+                argv[0]);
+        fprintf(stderr, "       %s --wait-cgroup <path> [--timeout <duration>] [--multiline] [--quiet]\n", argv[0]);
+        fprintf(stderr, "       %s --burn <threads> --duty <percent> [--period <duration>] [--duration <duration>]\n",
+                argv[0]);
         return 1;
     }
 
     int multiline = 0;
     int quiet = 0;
     long total = -1;
+    long limit_pid = 0;
+    double cpu_share = -1;
+    long long period_ns = 100000000LL;
+    long long duration_ns = -1;
+    long burn_threads = 0;
+    double duty = -1;
+    long chaos_pid = 0;
+    int chaos_group = 0;
+    long long pause_ns = -1;
+    long long every_ns = -1;
+    long long jitter_ns = 0;
+    long long heartbeat_ns = -1;
+    const char *notify_socket = NULL;
+    const char *heartbeat_file = NULL;
+    long long heartbeat_offset = 0;
+    const char *liveness_file = NULL;
+    long long stall_ns = -1;
+    char **command = NULL;
+    int budget_query = 0;
+    double speed = 1;
+    const char *wait_cgroup = NULL;
+    int dry_run = 0;
+    struct sink *sinks = calloc((size_t)argc + 1, sizeof(*sinks));
+    int sink_count = 0;
+    if (!sinks) {
+        fprintf(stderr, "Error: out of memory.\n");
+        return 1;
+    }
+#ifdef __linux__
+    struct hook *hooks = calloc((size_t)argc, sizeof(*hooks));
+    int hook_count = 0;
+    if (!hooks) {
+        fprintf(stderr, "Error: out of memory.\n");
+        return 1;
+    }
+#endif
 
     /* Parse arguments */
     for (int i = 1; i < argc; i++) {
@@ -95,8 +1488,166 @@ int main(int argc, char *argv[]) {
             multiline = 1;
         } else if (strcmp(argv[i], "--quiet") == 0 || strcmp(argv[i], "-q") == 0) {
             quiet = 1;
+        } else if (strcmp(argv[i], "--sink") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            if (!v) return 1;
+            if (parse_sink(v, &sinks[sink_count++]) != 0) {
+                fprintf(stderr, "Error: --sink expects bar|lines|jsonl|metrics[:<path>][@<rate>]"
+                        " (metrics needs a path).\n");
+                return 1;
+            }
+            /* Two writer threads would interleave their frames on one stream */
+            for (int j = 0; j + 1 < sink_count; ++j) {
+                if (sink_on_stdout(&sinks[j]) && sink_on_stdout(&sinks[sink_count - 1])) {
+                    fprintf(stderr, "Error: only one --sink may write to stdout.\n");
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "--on") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            if (!v) return 1;
+#ifdef __linux__
+            if (parse_hook(v, &hooks[hook_count++]) != 0) {
+                fprintf(stderr, "Error: --on expects <n>%%, elapsed=<d>, remaining=<d> or done, then :<cmd>.\n");
+                return 1;
+            }
+#else
+            fprintf(stderr, "Error: --on is only supported on Linux.\n");
+            return 1;
+#endif
+        } else if (strcmp(argv[i], "--speed") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            char *end = NULL;
+            if (!v) return 1;
+            errno = 0;
+            speed = strtod(v, &end);
+            if (errno != 0 || end == v || (*end != '\0' && strcmp(end, "x") != 0) || !(speed > 0)) {
+                fprintf(stderr, "Error: --speed must be a positive factor (e.g. 1000x).\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--dry-run") == 0) {
+            dry_run = 1;
+        } else if (strcmp(argv[i], "--budget-remaining") == 0) {
+            budget_query = 1;
+        } else if (strcmp(argv[i], "--limit-pid") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            char *end = NULL;
+            if (!v) return 1;
+            errno = 0;
+            limit_pid = strtol(v, &end, 10);
+            if (errno != 0 || end == v || *end != '\0' || limit_pid <= 0) {
+                fprintf(stderr, "Error: --limit-pid must be a positive process id.\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--cpu") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            if (!v) return 1;
+            if ((cpu_share = parse_percent(v, 0)) < 0) {
+                fprintf(stderr, "Error: --cpu must be a percentage in (0, 100].\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--period") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            if (!v) return 1;
+            if ((period_ns = parse_duration_ns(v)) <= 0) {
+                fprintf(stderr, "Error: --period must be a positive duration (e.g. 100ms).\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--burn") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            char *end = NULL;
+            if (!v) return 1;
+            errno = 0;
+            burn_threads = strtol(v, &end, 10);
+            if (errno != 0 || end == v || *end != '\0' || burn_threads <= 0 || burn_threads > 4096) {
+                fprintf(stderr, "Error: --burn must be a thread count between 1 and 4096.\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--duty") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            if (!v) return 1;
+            if ((duty = parse_percent(v, 0)) < 0) {
+                fprintf(stderr, "Error: --duty must be a percentage in (0, 100].\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--chaos-pid") == 0 || strcmp(argv[i], "--chaos-pgid") == 0) {
+            chaos_group = (strcmp(argv[i], "--chaos-pgid") == 0);
+            const char *v = option_value(argc, argv, &i);
+            char *end = NULL;
+            if (!v) return 1;
+            errno = 0;
+            chaos_pid = strtol(v, &end, 10);
+            if (errno != 0 || end == v || *end != '\0' || chaos_pid <= 0) {
+                fprintf(stderr, "Error: %s must be a positive process id.\n", argv[i - 1]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--pause") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            if (!v) return 1;
+            if ((pause_ns = parse_duration_ns(v)) <= 0) {
+                fprintf(stderr, "Error: --pause must be a positive duration (e.g. 50ms).\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--every") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            if (!v) return 1;
+            if ((every_ns = parse_duration_ns(v)) <= 0) {
+                fprintf(stderr, "Error: --every must be a positive duration (e.g. 2s).\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--jitter") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            if (!v) return 1;
+            if ((jitter_ns = parse_duration_ns(v)) < 0) {
+                fprintf(stderr, "Error: --jitter must be a duration (e.g. 1s).\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--heartbeat") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            if (!v) return 1;
+            if ((heartbeat_ns = parse_duration_ns(v)) <= 0) {
+                fprintf(stderr, "Error: --heartbeat must be a positive duration (e.g. 10s).\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--notify-socket") == 0) {
+            if (!(notify_socket = option_value(argc, argv, &i))) return 1;
+        } else if (strcmp(argv[i], "--heartbeat-file") == 0) {
+            if (!(heartbeat_file = option_value(argc, argv, &i))) return 1;
+        } else if (strcmp(argv[i], "--heartbeat-offset") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            char *end = NULL;
+            if (!v) return 1;
+            errno = 0;
+            heartbeat_offset = strtoll(v, &end, 10);
+            if (errno != 0 || end == v || *end != '\0' || heartbeat_offset < 0) {
+                fprintf(stderr, "Error: --heartbeat-offset must be a non-negative byte offset.\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--liveness-file") == 0) {
+            if (!(liveness_file = option_value(argc, argv, &i))) return 1;
+        } else if (strcmp(argv[i], "--stall") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            if (!v) return 1;
+            if ((stall_ns = parse_duration_ns(v)) <= 0) {
+                fprintf(stderr, "Error: --stall must be a positive duration (e.g. 30s).\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--") == 0) {
+            /* Everything after -- is the command to run */
+            if (i + 1 < argc) command = &argv[i + 1];
+            break;
+        } else if (strcmp(argv[i], "--wait-cgroup") == 0) {
+            if (!(wait_cgroup = option_value(argc, argv, &i))) return 1;
+        } else if (strcmp(argv[i], "--duration") == 0 || strcmp(argv[i], "--timeout") == 0) {
+            const char *v = option_value(argc, argv, &i);
+            if (!v) return 1;
+            if ((duration_ns = parse_duration_ns(v)) < 0) {
+                fprintf(stderr, "Error: %s must be a duration (e.g. 10m).\n", argv[i - 1]);
+                return 1;
+            }
         } else if (total == -1) {
             char *end = NULL;
+            errno = 0;
             total = strtol(argv[i], &end, 10);
             if (errno != 0 || end == argv[i] || *end != '\0' || total < 0) {
                 fprintf(stderr, "Error: <seconds> must be a non-negative integer.\n");
@@ -105,52 +1656,251 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    long long parent_deadline = inherited_deadline_ns();
+    if (budget_query) {
+        /* For scripts: seconds left in the enclosing budget, "inf" outside any sleeper */
+        if (parent_deadline < 0) {
+            printf("inf\n");
+            return 0;
+        }
+        long long left = parent_deadline - now_ns();
+        printf("%.3f\n", left > 0 ? left / 1e9 : 0.0);
+        return left > 0 ? 0 : 1;
+    }
+
+    if (dry_run) speed = 0;
+    if (speed != 1 && (burn_threads > 0 || heartbeat_ns > 0 || chaos_pid > 0 || limit_pid > 0 || wait_cgroup)) {
+        fprintf(stderr, "Error: --speed and --dry-run only apply to the countdown.\n");
+        return 1;
+    }
+#ifdef __linux__
+    if (hook_count > 0 && (burn_threads > 0 || heartbeat_ns > 0 || chaos_pid > 0 || limit_pid > 0 || wait_cgroup)) {
+        fprintf(stderr, "Error: --on only applies to the countdown.\n");
+        return 1;
+    }
+#endif
+
+    /* --duration and the positional <seconds> are interchangeable */
+    if (duration_ns < 0 && total >= 0) duration_ns = total * NS_PER_SEC;
+
+    /*
+     * An explicit duration never outlives an enclosing sleeper. Modes run
+     * without one stay unbounded: the inherited deadline only caps waits, it
+     * must not start stopping processes nobody asked us to stop. Virtual-clock
+     * runs neither cap nor export: their durations are not real time.
+     */
+    long long requested_ns = duration_ns;
+    int capped = 0;
+    if (parent_deadline >= 0 && duration_ns >= 0 && speed == 1) {
+        long long left = parent_deadline - now_ns();
+        if (left < 0) left = 0;
+        if (duration_ns > left) {
+            capped = 1;
+            duration_ns = left;
+        }
+    }
+    if (duration_ns >= 0) {
+        if (speed == 1) export_deadline_ns(now_ns() + duration_ns);
+        total = (long)((duration_ns + NS_PER_SEC - 1) / NS_PER_SEC);
+    }
+
+    if (wait_cgroup) {
+#ifdef __linux__
+        install_handler();
+        /* Uncapped: a parent deadline reached first must end the wait without the kill */
+        return run_wait_cgroup(wait_cgroup, requested_ns, parent_deadline, multiline, quiet);
+#else
+        (void)requested_ns;
+        fprintf(stderr, "Error: --wait-cgroup is only supported on Linux.\n");
+        return 1;
+#endif
+    }
+
+    if (burn_threads > 0) {
+        if (duty < 0) {
+            fprintf(stderr, "Error: --burn requires --duty <percent>.\n");
+            return 1;
+        }
+#ifdef __linux__
+        install_handler();
+        return run_burn((int)burn_threads, duty, period_ns, duration_ns, multiline, quiet);
+#else
+        fprintf(stderr, "Error: --burn is only supported on Linux.\n");
+        return 1;
+#endif
+    }
+
+    if (heartbeat_ns > 0) {
+        if (!command) {
+            fprintf(stderr, "Error: --heartbeat requires a command after --.\n");
+            return 1;
+        }
+        if (!notify_socket && !heartbeat_file) notify_socket = getenv("NOTIFY_SOCKET");
+        if (!notify_socket && !heartbeat_file) {
+            fprintf(stderr, "Error: --heartbeat needs --notify-socket, --heartbeat-file or $NOTIFY_SOCKET.\n");
+            return 1;
+        }
+        if (liveness_file && stall_ns < 0) stall_ns = 3 * heartbeat_ns;
+#ifdef __linux__
+        struct heartbeat hb;
+        if (heartbeat_open(&hb, notify_socket, heartbeat_file, (off_t)heartbeat_offset) != 0) return 1;
+        install_handler();
+        int status = run_heartbeat(heartbeat_ns, &hb, liveness_file, stall_ns, duration_ns, command);
+        heartbeat_close(&hb);
+        return status;
+#else
+        fprintf(stderr, "Error: --heartbeat is only supported on Linux.\n");
+        return 1;
+#endif
+    }
+
+    if (chaos_pid > 0) {
+        if (pause_ns < 0 || every_ns < 0) {
+            fprintf(stderr, "Error: --chaos-pid requires --pause and --every.\n");
+            return 1;
+        }
+#ifdef __linux__
+        /* Nothing would be left to send the SIGCONT */
+        if (chaos_group ? (pid_t)chaos_pid == getpgrp() : (pid_t)chaos_pid == getpid()) {
+            fprintf(stderr, "Error: %s would pause sleeper itself.\n",
+                    chaos_group ? "--chaos-pgid" : "--chaos-pid");
+            return 1;
+        }
+        install_handler();
+        return run_chaos((pid_t)chaos_pid, chaos_group, pause_ns, every_ns, jitter_ns, duration_ns, quiet);
+#else
+        (void)chaos_group;
+        fprintf(stderr, "Error: --chaos-pid is only supported on Linux.\n");
+        return 1;
+#endif
+    }
+
+    if (limit_pid > 0) {
+        if (cpu_share < 0) {
+            fprintf(stderr, "Error: --limit-pid requires --cpu <percent>.\n");
+            return 1;
+        }
+#ifdef __linux__
+        if ((pid_t)limit_pid == getpid()) {
+            fprintf(stderr, "Error: --limit-pid would stop sleeper itself.\n");
+            return 1;
+        }
+        install_handler();
+        return run_limit((pid_t)limit_pid, cpu_share, period_ns, duration_ns, multiline, quiet);
+#else
+        fprintf(stderr, "Error: --limit-pid is only supported on Linux.\n");
+        return 1;
+#endif
+    }
+
     if (total == -1) {
         fprintf(stderr, "Error: Missing <seconds> argument.\n");
         return 1;
     }
 
+    /* Without explicit sinks, --multiline and --quiet pick the classic terminal output */
+    if (sink_count == 0 && !quiet) {
+        sinks[sink_count].kind = multiline ? SINK_LINES : SINK_BAR;
+        sinks[sink_count].every_ns = NS_PER_SEC;
+        sink_count++;
+    }
+
+    for (int i = 0; i < sink_count; ++i) sinks[i].lossless = (speed != 1);
+
     install_handler();
 
+    struct sleeper_clock clk;
+    clock_init(&clk, speed);
+
     /* Calculate Start and ETA times */
-    time_t now = time(NULL);
+    long long start = clk.now(&clk);
+    long long wall_start = clock_wall_ns(&clk);
+    time_t now = (time_t)(wall_start / NS_PER_SEC);
     time_t finish = now + total;
+#ifdef __linux__
+    resolve_hooks(hooks, hook_count, duration_ns);
+#endif
 
     char start_str[10], eta_str[10];
     strftime(start_str, sizeof(start_str), "%H:%M:%S", localtime(&now));
     strftime(eta_str, sizeof(eta_str), "%H:%M:%S", localtime(&finish));
 
     printf("Start Time: %s | ETA: %s\n", start_str, eta_str);
-    printf("Sleeping for %ld second%s...\n", total, (total == 1 ? "" : "s"));
+    if (capped) printf("Sleeping for %.3f seconds (capped by the enclosing deadline)...\n", duration_ns / 1e9);
+    else if (duration_ns % NS_PER_SEC) printf("Sleeping for %.3f seconds...\n", duration_ns / 1e9);
+    else printf("Sleeping for %ld second%s...\n", total, (total == 1 ? "" : "s"));
+    /* Kept off stdout so a rehearsal prints exactly what the real run would */
+    if (dry_run) fprintf(stderr, "Dry run: not waiting, hooks are not started.\n");
+    else if (speed != 1) fprintf(stderr, "Running at %gx speed on a virtual clock.\n", speed);
 
-    long elapsed = 0;
-    while (elapsed <= total) {
-        if (!quiet) {
-            if (multiline) {
-                printf("Elapsed: %4ld s | Remaining: %4ld s", elapsed, total - elapsed);
-                print_bar(elapsed, total);
-                printf("\n");
-            } else {
-                /* \r returns cursor to start of line */
-                printf("\rElapsed: %4ld s | Remaining: %4ld s", elapsed, total - elapsed);
-                print_bar(elapsed, total);
-                printf("    ");
-                fflush(stdout);
-            }
+    fflush(stdout);
+    for (int i = 0; i < sink_count; ++i) {
+        if (sink_start(&sinks[i]) != 0) {
+            while (i-- > 0) sink_close(&sinks[i]);
+            return 1;
         }
+    }
 
-        if (elapsed == total) break;
+    int status = 0;
+    long long offset = 0;
+    for (;;) {
+        /* Post every frame that has fallen due; a sink that missed whole periods skips them */
+        long long wake = duration_ns;
+        for (int i = 0; i < sink_count; ++i) {
+            struct sink *sk = &sinks[i];
+            if (sk->next_ns <= offset && sk->next_ns < duration_ns) {
+                struct frame f = { sk->next_ns, duration_ns, FRAME_RUNNING, frame_wall_ns(&clk, wall_start, sk->next_ns) };
+                sink_post(sk, &f);
+                sk->next_ns += sk->every_ns;
+                while (sk->next_ns + sk->every_ns <= offset) sk->next_ns += sk->every_ns;
+            }
+            if (sk->next_ns < wake) wake = sk->next_ns;
+        }
+        if (offset >= duration_ns) break;
 
         /* Check for interrupt before and during sleep */
-        if (was_interrupted() || sleep_one_second() != 0 || was_interrupted()) {
-            if (!quiet && !multiline) putchar('\n');
-            fprintf(stderr, "Interrupted at %ld/%ld seconds.\n", elapsed, total);
-            return 130;
+#ifdef __linux__
+        int slept = (hook_count > 0) ? hooks_wait_until(&clk, hooks, hook_count, start, start + wake)
+                                     : clk.sleep_until(&clk, start + wake);
+#else
+        int slept = clk.sleep_until(&clk, start + wake);
+#endif
+        if (was_interrupted() || slept != 0 || was_interrupted()) {
+            status = 130;
+            break;
         }
-        elapsed++;
+        offset = clk.now(&clk) - start;
+        if (offset < wake) offset = wake;
     }
 
-    if (!quiet && !multiline) putchar('\n');
-    printf("Done. Total time: %lds.\n", total);
+    if (status) offset = clk.now(&clk) - start;
+    else offset = duration_ns;
+    /* Every final frame is posted before any sink is closed, so a slow sink cannot hold back the rest */
+    struct frame last = { offset, duration_ns, status ? FRAME_INTERRUPTED : FRAME_DONE,
+                          frame_wall_ns(&clk, wall_start, offset) };
+    for (int i = 0; i < sink_count; ++i) sink_post(&sinks[i], &last);
+    for (int i = 0; i < sink_count; ++i) sink_close(&sinks[i]);
+    free(sinks);
+
+    if (status == 130) {
+        fprintf(stderr, "Interrupted at %lld/%ld seconds.\n", offset / NS_PER_SEC, total);
+#ifdef __linux__
+        hooks_abort(hooks, hook_count);
+        free(hooks);
+#endif
+        return 130;
+    }
+#ifdef __linux__
+    fflush(stdout);
+    if (hooks_finish(hooks, hook_count, dry_run) != 0) {
+        fprintf(stderr, "Interrupted while waiting for hooks.\n");
+        hooks_abort(hooks, hook_count);
+        free(hooks);
+        return 130;
+    }
+    free(hooks);
+#endif
+    if (capped || duration_ns % NS_PER_SEC) printf("Done. Total time: %.3fs.\n", duration_ns / 1e9);
+    else printf("Done. Total time: %lds.\n", total);
     return 0;
 }
\ No newline at end of file